@@ -3,7 +3,27 @@
 #include <string>
 #include <bitset>
 #include <cstdlib>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <type_traits>
+#include <fstream>
 #include <stdexcept>
+#if __cplusplus >= 202002L
+#include <compare>
+#endif
 
 using namespace std;
 
@@ -14,13 +34,106 @@ typedef unsigned short DBASE;
 #define DBASE_SIZE (sizeof(DBASE) * 8)
 #define BASENUM ((DBASE)1 << BASE_SIZE)
 
+// Algorithm crossover points, in limbs. These are the compiled-in defaults; the
+// profile written by "BigNumber --tune" overrides them (see thresholds()).
+#define KARATSUBA_THRESHOLD 48          // both factors at least this long -> Karatsuba
+#define DC_RADIX_THRESHOLD 256          // ToDecimal: divide and conquer from this length
+#define PARALLEL_THRESHOLD 16384        // product tree: halves on two threads above this many limbs
+#define BIGNUMBER_PROFILE_PATH "bignumber.profile"   // used when $BIGNUMBER_PROFILE is not set
+
+// 1: every BigNumber remembers its hash once computed (one extra size_t per number)
+#ifndef BIGNUMBER_HASH_CACHE
+#define BIGNUMBER_HASH_CACHE 1
+#endif
+
+
+// xoshiro256** generator. Every thread owns its own engine (see thread_engine()),
+// so nothing is shared between threads and nobody waits on rand().
+class RandomEngine{
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+public:
+    explicit RandomEngine(uint64_t seed = 0) { Seed(seed); }
+
+    void Seed(uint64_t seed);
+    uint64_t Next();
+    void Fill(BASE* buf, size_t n);     // n random limbs, one Next() per 8 bytes
+};
+
+RandomEngine& thread_engine();
+void seed_random(uint64_t seed);        // reseeds the engine of the calling thread
+
+class OperationCancelled : public runtime_error{
+public:
+    OperationCancelled() : runtime_error("BigNumber: operation cancelled") {}
+};
+
+// Cooperative cancellation: copies share one flag, the owner calls Cancel() and
+// long-running code calls cancel_point() between steps. A deadline cancels by itself.
+class CancelToken{
+    struct State {
+        atomic<bool> cancelled{false};
+        bool has_deadline = false;
+        chrono::steady_clock::time_point deadline;
+    };
+    shared_ptr<State> state;
+public:
+    CancelToken() : state(make_shared<State>()) {}
+
+    static CancelToken WithDeadline(chrono::steady_clock::time_point deadline);
+    static CancelToken WithTimeout(chrono::milliseconds timeout);
+
+    void Cancel() { state->cancelled = true; }
+    bool IsCancelled() const;
+    void Check() const { if (IsCancelled()) throw OperationCancelled(); }
+
+    friend void cancel_point();
+};
+
+// token of the task running on this thread (set by AsyncExecutor), nullptr outside of tasks
+extern thread_local const CancelToken* current_cancel_token;
+inline void cancel_point();
+
+template<class E> struct LazyExpr;
+struct LazyTerms;
+
 class BigNumber{
     vector<BASE> coefs;
+#if BIGNUMBER_HASH_CACHE
+    mutable atomic<size_t> hash_cache{0};   // 0 = not computed yet; copies start without it.
+                                            // atomic: const lookups may hash one number from several threads
+#endif
+    void invalidateHash()
+    {
+#if BIGNUMBER_HASH_CACHE
+        hash_cache.store(0, memory_order_relaxed);
+#endif
+    }
+
+    // single-pass kernels behind the machine-word operators
+    BigNumber& AddWord(uint64_t v);
+    BigNumber& SubWord(uint64_t v);
+    BigNumber& MulWord(uint64_t v);
+    uint64_t   DivWord(uint64_t v);         // *this /= v, returns the remainder
+    int        CompareWord(uint64_t v) const;
+    bool       IsZero() const { return coefs.empty() || (coefs.size() == 1 && coefs[0] == 0); }
+
+    template<class T> static bool IsNegative(T v)
+    {
+        if constexpr (is_signed<T>::value) return v < 0;
+        else return false;
+    }
+    template<class T> static uint64_t Magnitude(T v)
+    {
+        return IsNegative(v) ? 0 - (uint64_t)(int64_t)v : (uint64_t)v;
+    }
 public:
     BigNumber();                        // new default constructor (zero)
-    BigNumber(unsigned int len);        // constructor that creates random limbs (previously mode==1)
+    BigNumber(unsigned int len);        // constructor that creates random limbs (previously mode==1), uses thread_engine()
     BigNumber(string&);
     BigNumber(const BigNumber&);
+    template<class E> BigNumber(const LazyExpr<E>& e) : BigNumber() { e.self().evalTo(*this); }
     ~BigNumber() = default;
 
     bool operator== (const BigNumber&) const;
@@ -29,8 +142,15 @@ public:
     bool operator<  (const BigNumber&) const;
     bool operator>= (const BigNumber&) const;
     bool operator<= (const BigNumber&) const;
+#if __cplusplus >= 202002L
+    strong_ordering operator<=> (const BigNumber&) const;
+#endif
+
+    int compare(const BigNumber&) const;    // -1, 0, 1
+    size_t hash() const;
 
     BigNumber& operator=  (const BigNumber&);
+    template<class E> BigNumber& operator= (const LazyExpr<E>& e) { e.self().evalTo(*this); return *this; }
 
     BigNumber  operator+  (const BASE&);
     BigNumber& operator+= (const BASE&);
@@ -54,6 +174,52 @@ public:
     BigNumber  operator%  (const BigNumber&);
     BigNumber& operator%= (const BigNumber&);
 
+    // Machine-word operands: any integer type except BASE (which keeps the limb
+    // overloads above) and bool. Signed values go through their magnitude; a
+    // result below zero throws underflow_error like the BigNumber operators.
+    template<class T> using IfWideInt = typename enable_if<is_integral<T>::value && !is_same<T, BASE>::value && !is_same<T, bool>::value, int>::type;
+
+    template<class T, IfWideInt<T> = 0> BigNumber& operator+= (T v) { return IsNegative(v) ? SubWord(Magnitude(v)) : AddWord(Magnitude(v)); }
+    template<class T, IfWideInt<T> = 0> BigNumber& operator-= (T v) { return IsNegative(v) ? AddWord(Magnitude(v)) : SubWord(Magnitude(v)); }
+    template<class T, IfWideInt<T> = 0> BigNumber& operator*= (T v)
+    {
+        if (IsNegative(v) && !IsZero()) throw std::underflow_error("Negative result");
+        return MulWord(Magnitude(v));
+    }
+    template<class T, IfWideInt<T> = 0> BigNumber& operator/= (T v)
+    {
+        // nonzero quotient of a negative divisor: throw before *this is touched
+        if (IsNegative(v) && CompareWord(Magnitude(v)) >= 0) throw std::underflow_error("Negative result");
+        DivWord(Magnitude(v));
+        return *this;
+    }
+    template<class T, IfWideInt<T> = 0> BigNumber& operator%= (T v) { *this = FromWord(ModWord(Magnitude(v))); return *this; }
+
+    template<class T, IfWideInt<T> = 0> BigNumber operator+ (T v) { BigNumber res(*this); res += v; return res; }
+    template<class T, IfWideInt<T> = 0> BigNumber operator- (T v) { BigNumber res(*this); res -= v; return res; }
+    template<class T, IfWideInt<T> = 0> BigNumber operator* (T v) { BigNumber res(*this); res *= v; return res; }
+    template<class T, IfWideInt<T> = 0> BigNumber operator/ (T v) { BigNumber res(*this); res /= v; return res; }
+    template<class T, IfWideInt<T> = 0> BigNumber operator% (T v) { return FromWord(ModWord(Magnitude(v))); }
+
+    template<class T, IfWideInt<T> = 0> int compare(T v) const { return IsNegative(v) ? 1 : CompareWord(Magnitude(v)); }
+    template<class T, IfWideInt<T> = 0> bool operator== (T v) const { return compare(v) == 0; }
+    template<class T, IfWideInt<T> = 0> bool operator!= (T v) const { return compare(v) != 0; }
+    template<class T, IfWideInt<T> = 0> bool operator<  (T v) const { return compare(v) < 0; }
+    template<class T, IfWideInt<T> = 0> bool operator>  (T v) const { return compare(v) > 0; }
+    template<class T, IfWideInt<T> = 0> bool operator<= (T v) const { return compare(v) <= 0; }
+    template<class T, IfWideInt<T> = 0> bool operator>= (T v) const { return compare(v) >= 0; }
+
+    BigNumber DivRem(const BigNumber& other, BigNumber* rem, bool quotient = true) const;   // quotient, remainder into *rem;
+                                                                                            // quotient = false: only *rem, returns 0
+    string ToDecimal() const;
+    string DecimalNaive() const;                                // ToDecimal without divide and conquer
+
+    // fused multiply-accumulate, in place, one pass over *this
+    BigNumber& addmul(const BigNumber& a, const BASE& limb);     // *this += a * limb
+    BigNumber& submul(const BigNumber& a, const BASE& limb);     // *this -= a * limb
+    BigNumber& addmul(const BigNumber& a, const BigNumber& b);   // *this += a * b
+    BigNumber& muladd(const BASE& m, const BASE& c);             // *this = *this * m + c
+
     void OutputHex();
     void InputHex();
 
@@ -63,13 +229,347 @@ public:
     {
         return coefs.size();
     }
+
+    unsigned int getBitLength() const;
+    bool testBit(unsigned int i) const;
+    uint64_t ModWord(uint64_t m) const;           // remainder by a machine word, m > 0; *this is not changed
     
     void PrintBase256();
 
+    // build a number from a machine word (uint32_t / uint64_t); there is no such
+    // constructor because BigNumber(unsigned int) already means "random limbs"
+    static BigNumber FromWord(unsigned long long w);
+    static BigNumber FromInt64(int64_t w);                     // w < 0 -> underflow_error
+
+    bool fits_uint64() const;
+    uint64_t to_uint64() const;                                 // overflow_error if it does not fit
+
+    friend BigNumber product(const vector<BigNumber>&);
+
+    friend struct LazyWord;
+    friend void lazy_eval_sum(BigNumber& dest, LazyTerms& t);
+    friend void lazy_eval_mulmod(BigNumber& dest, const BigNumber& a, const BigNumber& b, const BigNumber& m);
+
+    friend BigNumber random_bits(unsigned int n, RandomEngine& eng);
+    friend BigNumber random_below(const BigNumber& bound, RandomEngine& eng);
+
     friend ostream& operator<< (ostream&, const BigNumber&);
     friend istream& operator>> (istream&, BigNumber&);
 };
 
+namespace std {
+    template<> struct hash<BigNumber> {
+        size_t operator()(const BigNumber& x) const noexcept { return x.hash(); }
+    };
+}
+
+// ---- lazy expressions (opt-in) ----
+/*
+    Wrapping one operand in lazy() turns the whole expression into a tree that is
+    evaluated only when assigned to a BigNumber:
+
+        r = lazy(a) + b + c - d;        // one carry pass over all four numbers
+        acc = lazy(acc) + lazy(x) * y;  // acc.addmul(x, y), no temporary product
+        r = (lazy(a) * b) % m;          // lazy_eval_mulmod, r's storage is reused
+
+    Integer operands follow the word operators: lazy(a) + 1000 == a + 1000.
+    Only the lazy() side is deferred: in lazy(a) + b * c the product b * c is an
+    ordinary BigNumber. Nodes keep references to their operands, so evaluate the
+    expression in the same statement (do not keep it in an auto variable).
+*/
+
+// what an add/sub chain flattens to
+struct LazyTerms {
+    struct Term { const BigNumber* x; int sign; };
+    struct Prod { const BigNumber* a; const BigNumber* b; BASE limb; int sign; };   // a * b, or a * limb when b == nullptr
+
+    vector<Term> terms;
+    vector<Prod> prods;
+    deque<BigNumber> temps;         // operands that had to be evaluated first (stable addresses)
+};
+
+void lazy_eval_sum(BigNumber& dest, LazyTerms& t);
+void lazy_eval_mulmod(BigNumber& dest, const BigNumber& a, const BigNumber& b, const BigNumber& m);
+
+template<class E> struct LazyExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+
+    // by default a node is evaluated on its own and enters a sum as one term
+    void collect(LazyTerms& t, int sign) const
+    {
+        t.temps.emplace_back(self());
+        t.terms.push_back({ &t.temps.back(), sign });
+    }
+};
+
+struct LazyRef : LazyExpr<LazyRef> {
+    const BigNumber& x;
+    explicit LazyRef(const BigNumber& x) : x(x) {}
+
+    void collect(LazyTerms& t, int sign) const { t.terms.push_back({ &x, sign }); }
+    void evalTo(BigNumber& dest) const { dest = x; }
+};
+
+struct LazyLimb : LazyExpr<LazyLimb> {
+    BASE v;
+    explicit LazyLimb(BASE v) : v(v) {}
+
+    void evalTo(BigNumber& dest) const { dest = BigNumber::FromWord(v); }
+};
+
+// machine-word operand (any IfWideInt type): magnitude plus sign, like the
+// BigNumber word operators, so lazy(a) + 1000 == a + 1000
+struct LazyWord : LazyExpr<LazyWord> {
+    uint64_t v; bool neg;
+    template<class T> explicit LazyWord(T w) : v(BigNumber::Magnitude(w)), neg(BigNumber::IsNegative(w)) {}
+
+    void collect(LazyTerms& t, int sign) const
+    {
+        t.temps.push_back(BigNumber::FromWord(v));
+        t.terms.push_back({ &t.temps.back(), neg ? -sign : sign });
+    }
+    void evalTo(BigNumber& dest) const
+    {
+        if (neg) throw std::underflow_error("Negative result");
+        dest = BigNumber::FromWord(v);
+    }
+};
+
+// operand of a product: the number itself for lazy(x), otherwise a temporary
+inline const BigNumber* lazy_operand(const LazyRef& e, LazyTerms&) { return &e.x; }
+template<class E> const BigNumber* lazy_operand(const LazyExpr<E>& e, LazyTerms& t)
+{
+    t.temps.emplace_back(e.self());
+    return &t.temps.back();
+}
+
+template<class L, class R> struct LazySum : LazyExpr<LazySum<L, R>> {
+    L l; R r; int sign_r;
+    LazySum(const L& l, const R& r, int sign_r) : l(l), r(r), sign_r(sign_r) {}
+
+    void collect(LazyTerms& t, int sign) const
+    {
+        l.collect(t, sign);
+        r.collect(t, sign * sign_r);
+    }
+    void evalTo(BigNumber& dest) const
+    {
+        LazyTerms t;
+        collect(t, 1);
+        lazy_eval_sum(dest, t);
+    }
+};
+
+template<class L, class R> struct LazyMul : LazyExpr<LazyMul<L, R>> {
+    L l; R r;
+    LazyMul(const L& l, const R& r) : l(l), r(r) {}
+
+    void collect(LazyTerms& t, int sign) const
+    {
+        const BigNumber* a = lazy_operand(l, t);
+        const BigNumber* b = lazy_operand(r, t);
+        t.prods.push_back({ a, b, 0, sign });
+    }
+    void evalTo(BigNumber& dest) const
+    {
+        LazyTerms t;
+        collect(t, 1);
+        lazy_eval_sum(dest, t);
+    }
+};
+
+template<class L> struct LazyMulLimb : LazyExpr<LazyMulLimb<L>> {
+    L l; BASE m;
+    LazyMulLimb(const L& l, BASE m) : l(l), m(m) {}
+
+    void collect(LazyTerms& t, int sign) const
+    {
+        t.prods.push_back({ lazy_operand(l, t), nullptr, m, sign });
+    }
+    void evalTo(BigNumber& dest) const
+    {
+        LazyTerms t;
+        collect(t, 1);
+        lazy_eval_sum(dest, t);
+    }
+};
+
+// x * word: a product term whose sign also carries the sign of the word
+template<class L> struct LazyMulWord : LazyExpr<LazyMulWord<L>> {
+    L l; LazyWord w;
+    LazyMulWord(const L& l, const LazyWord& w) : l(l), w(w) {}
+
+    void collect(LazyTerms& t, int sign) const
+    {
+        const BigNumber* a = lazy_operand(l, t);
+        t.temps.push_back(BigNumber::FromWord(w.v));
+        t.prods.push_back({ a, &t.temps.back(), 0, w.neg ? -sign : sign });
+    }
+    void evalTo(BigNumber& dest) const
+    {
+        LazyTerms t;
+        collect(t, 1);
+        lazy_eval_sum(dest, t);
+    }
+};
+
+template<class L, class R> struct LazyMod : LazyExpr<LazyMod<L, R>> {
+    L l; R r;
+    LazyMod(const L& l, const R& r) : l(l), r(r) {}
+
+    void evalTo(BigNumber& dest) const
+    {
+        LazyTerms t;
+        const BigNumber* m = lazy_operand(r, t);
+        evalLeft(dest, l, *m, t);
+    }
+private:
+    // (x * y) % m goes to the mulmod kernel, anything else is evaluated and reduced
+    template<class A, class B>
+    static void evalLeft(BigNumber& dest, const LazyMul<A, B>& mul, const BigNumber& m, LazyTerms& t)
+    {
+        lazy_eval_mulmod(dest, *lazy_operand(mul.l, t), *lazy_operand(mul.r, t), m);
+    }
+    template<class E>
+    static void evalLeft(BigNumber& dest, const LazyExpr<E>& e, const BigNumber& m, LazyTerms& t)
+    {
+        BigNumber x(e.self());
+        dest = x % BigNumber(m);
+    }
+};
+
+inline LazyRef lazy(const BigNumber& x) { return LazyRef(x); }
+
+template<class L, class R> LazySum<L, R> operator+ (const LazyExpr<L>& l, const LazyExpr<R>& r) { return LazySum<L, R>(l.self(), r.self(), 1); }
+template<class L> LazySum<L, LazyRef> operator+ (const LazyExpr<L>& l, const BigNumber& r) { return LazySum<L, LazyRef>(l.self(), LazyRef(r), 1); }
+template<class R> LazySum<LazyRef, R> operator+ (const BigNumber& l, const LazyExpr<R>& r) { return LazySum<LazyRef, R>(LazyRef(l), r.self(), 1); }
+template<class L> LazySum<L, LazyLimb> operator+ (const LazyExpr<L>& l, const BASE& r) { return LazySum<L, LazyLimb>(l.self(), LazyLimb(r), 1); }
+template<class L, class T, BigNumber::IfWideInt<T> = 0> LazySum<L, LazyWord> operator+ (const LazyExpr<L>& l, T r) { return LazySum<L, LazyWord>(l.self(), LazyWord(r), 1); }
+
+template<class L, class R> LazySum<L, R> operator- (const LazyExpr<L>& l, const LazyExpr<R>& r) { return LazySum<L, R>(l.self(), r.self(), -1); }
+template<class L> LazySum<L, LazyRef> operator- (const LazyExpr<L>& l, const BigNumber& r) { return LazySum<L, LazyRef>(l.self(), LazyRef(r), -1); }
+template<class R> LazySum<LazyRef, R> operator- (const BigNumber& l, const LazyExpr<R>& r) { return LazySum<LazyRef, R>(LazyRef(l), r.self(), -1); }
+template<class L> LazySum<L, LazyLimb> operator- (const LazyExpr<L>& l, const BASE& r) { return LazySum<L, LazyLimb>(l.self(), LazyLimb(r), -1); }
+template<class L, class T, BigNumber::IfWideInt<T> = 0> LazySum<L, LazyWord> operator- (const LazyExpr<L>& l, T r) { return LazySum<L, LazyWord>(l.self(), LazyWord(r), -1); }
+
+template<class L, class R> LazyMul<L, R> operator* (const LazyExpr<L>& l, const LazyExpr<R>& r) { return LazyMul<L, R>(l.self(), r.self()); }
+template<class L> LazyMul<L, LazyRef> operator* (const LazyExpr<L>& l, const BigNumber& r) { return LazyMul<L, LazyRef>(l.self(), LazyRef(r)); }
+template<class R> LazyMul<LazyRef, R> operator* (const BigNumber& l, const LazyExpr<R>& r) { return LazyMul<LazyRef, R>(LazyRef(l), r.self()); }
+template<class L> LazyMulLimb<L> operator* (const LazyExpr<L>& l, const BASE& r) { return LazyMulLimb<L>(l.self(), r); }
+template<class L, class T, BigNumber::IfWideInt<T> = 0> LazyMulWord<L> operator* (const LazyExpr<L>& l, T r) { return LazyMulWord<L>(l.self(), LazyWord(r)); }
+
+template<class L, class R> LazyMod<L, R> operator% (const LazyExpr<L>& l, const LazyExpr<R>& r) { return LazyMod<L, R>(l.self(), r.self()); }
+template<class L> LazyMod<L, LazyRef> operator% (const LazyExpr<L>& l, const BigNumber& r) { return LazyMod<L, LazyRef>(l.self(), LazyRef(r)); }
+
+// ---- asynchronous computation ----
+/*
+    AsyncExecutor: a fixed number of worker threads and a bounded queue; Submit()
+    blocks while the queue is full. Every task runs with its CancelToken installed
+    as current_cancel_token, so operator*, the division, addmul and ToDecimal stop
+    at their next checkpoint with OperationCancelled once the token is cancelled
+    or its deadline passes. The exception comes out of future::get().
+
+        CancelToken tok = CancelToken::WithTimeout(chrono::milliseconds(200));
+        future<BigNumber> f = async_mul(a, b, tok);
+        ...
+        tok.Cancel();                       // client went away
+*/
+
+class AsyncExecutor{
+    vector<thread> workers;
+    deque<function<void()>> tasks;
+    size_t capacity;
+    bool stopping = false;
+    mutex mtx;
+    condition_variable not_empty, not_full;
+
+    void WorkerLoop();
+public:
+    explicit AsyncExecutor(unsigned threads = max(1u, thread::hardware_concurrency()), size_t capacity = 1024);
+    ~AsyncExecutor();                       // runs what is already queued, then joins
+    AsyncExecutor(const AsyncExecutor&) = delete;
+    AsyncExecutor& operator= (const AsyncExecutor&) = delete;
+
+    template<class F> auto Submit(F f, CancelToken tok = CancelToken()) -> future<decltype(f())>;
+};
+
+AsyncExecutor& default_executor();
+
+// installs a token as current_cancel_token for the lifetime of the scope
+class CancelScope{
+    const CancelToken* prev;
+public:
+    explicit CancelScope(const CancelToken& tok) : prev(current_cancel_token) { current_cancel_token = &tok; }
+    ~CancelScope() { current_cancel_token = prev; }
+};
+
+template<class F> auto AsyncExecutor::Submit(F f, CancelToken tok) -> future<decltype(f())>
+{
+    using R = decltype(f());
+    auto task = make_shared<packaged_task<R()>>([f = move(f), tok]() mutable {
+        CancelScope scope(tok);
+        tok.Check();                        // cancelled while waiting in the queue
+        return f();
+    });
+    future<R> res = task->get_future();
+    {
+        unique_lock<mutex> lock(mtx);
+        not_full.wait(lock, [this] { return tasks.size() < capacity || stopping; });
+        if (stopping) throw runtime_error("AsyncExecutor: submit after shutdown");
+        tasks.push_back([task] { (*task)(); });
+    }
+    not_empty.notify_one();
+    return res;
+}
+
+future<BigNumber> async_mul(const BigNumber& a, const BigNumber& b, CancelToken tok = CancelToken(), AsyncExecutor& ex = default_executor());
+future<BigNumber> async_div(const BigNumber& a, const BigNumber& b, CancelToken tok = CancelToken(), AsyncExecutor& ex = default_executor());
+future<BigNumber> async_mod(const BigNumber& a, const BigNumber& b, CancelToken tok = CancelToken(), AsyncExecutor& ex = default_executor());
+future<string> async_to_string(const BigNumber& a, CancelToken tok = CancelToken(), AsyncExecutor& ex = default_executor());
+
+// ---- algorithm thresholds ----
+// Fields are atomic: operator*, ProductTree and ToDecimal read them from executor
+// and std::async threads while main or tune_thresholds() may assign new values.
+// Each field is read once per decision, so a change takes effect at the next call.
+struct Thresholds {
+    atomic<size_t> karatsuba_limbs{KARATSUBA_THRESHOLD};
+    atomic<size_t> dc_radix_limbs{DC_RADIX_THRESHOLD};
+    atomic<size_t> parallel_limbs{PARALLEL_THRESHOLD};
+
+    Thresholds() = default;
+    Thresholds(const Thresholds& o) { *this = o; }
+    Thresholds& operator= (const Thresholds& o)
+    {
+        karatsuba_limbs.store(o.karatsuba_limbs.load(memory_order_relaxed), memory_order_relaxed);
+        dc_radix_limbs.store(o.dc_radix_limbs.load(memory_order_relaxed), memory_order_relaxed);
+        parallel_limbs.store(o.parallel_limbs.load(memory_order_relaxed), memory_order_relaxed);
+        return *this;
+    }
+};
+
+Thresholds& thresholds();               // loaded once: defaults, then the profile file if there is one
+bool load_thresholds(const string& path, Thresholds& t);
+bool save_thresholds(const string& path, const Thresholds& t);
+Thresholds tune_thresholds(ostream& log);
+
+// ---- product trees / combinatorics ----
+BigNumber product(const vector<BigNumber>& factors);
+BigNumber factorial(unsigned int n);
+BigNumber binomial(unsigned int n, unsigned int k);
+BigNumber primorial(unsigned int n);
+vector<BigNumber> remainder_tree(const BigNumber& x, const vector<BigNumber>& moduli);
+
+// ---- random numbers ----
+BigNumber random_bits(unsigned int n, RandomEngine& eng = thread_engine());                   // [0, 2^n)
+BigNumber random_below(const BigNumber& bound, RandomEngine& eng = thread_engine());          // [0, bound)
+BigNumber random_range(const BigNumber& lo, const BigNumber& hi, RandomEngine& eng = thread_engine()); // [lo, hi)
+
+// ---- primality ----
+BigNumber powmod(const BigNumber& base, const BigNumber& exp, const BigNumber& mod);
+bool is_probable_prime(const BigNumber& n, int rounds = 20);
+vector<unsigned int> sieve_candidates(const BigNumber& start, unsigned int width);   // offsets with no small factor
+BigNumber next_prime(const BigNumber& n);                                           // smallest prime > n
+
 
 
 
@@ -85,11 +585,10 @@ BigNumber::BigNumber() {
 BigNumber::BigNumber(unsigned int len){
     if (!len) return;
 
-    for (int i = 0; i < len-1; i++)
-        coefs.push_back(rand());
-    BASE coef = rand();
-    while (!coef) coef = rand();
-    coefs.push_back(coef);
+    RandomEngine& eng = thread_engine();
+    coefs.resize(len);
+    eng.Fill(coefs.data(), len);
+    while (!coefs[len - 1]) coefs[len - 1] = BASE(eng.Next());
 }
 
 
@@ -151,66 +650,108 @@ BigNumber::BigNumber(const BigNumber& other){
 // Added: comparison operators and assignment (merged implementations)
 bool BigNumber::operator== (const BigNumber& other) const
 {
+#if BIGNUMBER_HASH_CACHE
+    // both hashes known and different -> different numbers, no limb scan
+    size_t h1 = hash_cache.load(memory_order_relaxed), h2 = other.hash_cache.load(memory_order_relaxed);
+    if (h1 && h2 && h1 != h2) return false;
+#endif
     return coefs == other.coefs; // victor method
 }
 
 bool BigNumber::operator!= (const BigNumber& other) const
 {
-    return coefs != other.coefs; // victor method
+    return !(*this == other);
 }
 
 bool BigNumber::operator> (const BigNumber& other) const
 {
-    int len_l = coefs.size();
-    int len_r = other.coefs.size();
-
-    if (len_l > len_r)
-        return true;
-
-    if (len_l < len_r)
-        return false;
-
-    for (int i = len_l - 1; i >= 0; i--)
-    {
-        if (coefs[i] < other.coefs[i])
-            return false;
-        if (coefs[i] > other.coefs[i])
-            return true;
-    }
-
-    return false;
+    return compare(other) > 0;
 }
 
 bool BigNumber::operator< (const BigNumber& other) const
 {
-    int len_l = coefs.size();
-    int len_r = other.coefs.size();
+    return compare(other) < 0;
+}
+
+bool BigNumber::operator<= (const BigNumber& other) const
+{
+    return compare(other) <= 0;
+}
 
-    if (len_l < len_r)
-        return true;
+bool BigNumber::operator>= (const BigNumber& other) const
+{
+    return compare(other) >= 0;
+}
 
-    if (len_l > len_r)
-        return false;
+#if __cplusplus >= 202002L
+strong_ordering BigNumber::operator<=> (const BigNumber& other) const
+{
+    return compare(other) <=> 0;
+}
+#endif
 
-    for (int i = len_l - 1; i >= 0; i--)
-    {
-        if (coefs[i] > other.coefs[i])
-            return false;
-        if (coefs[i] < other.coefs[i])
-            return true;
-    }
+#define WORD_LIMBS (sizeof(uint64_t) / sizeof(BASE))
 
-    return false;
+// limbs p[0..7] as one 64-bit word (p[7] is the most significant), compiles to a single load
+static inline uint64_t LoadWord(const BASE* p)
+{
+    uint64_t w = 0;
+    for (int j = WORD_LIMBS - 1; j >= 0; j--)
+        w = (w << BASE_SIZE) | p[j];
+    return w;
 }
 
-bool BigNumber::operator<= (const BigNumber& other) const
+// one pass from the top, 8 limbs per step
+int BigNumber::compare(const BigNumber& other) const
 {
-    return !(*this > other);
+    size_t len_l = coefs.size();
+    size_t len_r = other.coefs.size();
+
+    if (len_l != len_r)
+        return len_l > len_r ? 1 : -1;
+
+    size_t i = len_l;
+    while (i >= WORD_LIMBS) {
+        i -= WORD_LIMBS;
+        uint64_t a = LoadWord(&coefs[i]);
+        uint64_t b = LoadWord(&other.coefs[i]);
+        if (a != b) return a > b ? 1 : -1;
+    }
+    while (i > 0) {
+        i--;
+        if (coefs[i] != other.coefs[i]) return coefs[i] > other.coefs[i] ? 1 : -1;
+    }
+    return 0;
 }
 
-bool BigNumber::operator>= (const BigNumber& other) const
+// multiply-xorshift over 64-bit words, the length goes into the seed
+size_t BigNumber::hash() const
 {
-    return !(*this < other);
+#if BIGNUMBER_HASH_CACHE
+    if (size_t cached = hash_cache.load(memory_order_relaxed)) return cached;
+#endif
+    const uint64_t k = 0x9e3779b97f4a7c15ULL;
+    uint64_t h = coefs.size() * k;
+
+    size_t i = 0;
+    for (; i + WORD_LIMBS <= coefs.size(); i += WORD_LIMBS) {
+        h = (h ^ LoadWord(&coefs[i])) * k;
+        h ^= h >> 32;
+    }
+    if (i < coefs.size()) {
+        uint64_t w = 0;
+        for (size_t j = coefs.size(); j > i; j--)
+            w = (w << BASE_SIZE) | coefs[j - 1];
+        h = (h ^ w) * k;
+        h ^= h >> 32;
+    }
+    h ^= h >> 29;
+    if (h == 0) h = 1;      // 0 marks "not cached"
+
+#if BIGNUMBER_HASH_CACHE
+    hash_cache.store((size_t)h, memory_order_relaxed);
+#endif
+    return (size_t)h;
 }
 
 BigNumber& BigNumber::operator= (const BigNumber& other)
@@ -220,6 +761,7 @@ BigNumber& BigNumber::operator= (const BigNumber& other)
         coefs.clear();
         for (int i = 0; i < other.coefs.size(); i++)
             coefs.push_back(other.coefs[i]);
+        invalidateHash();
     }
     return *this;
 }
@@ -404,92 +946,541 @@ BigNumber& BigNumber::operator%= (const BASE& num)
 
 
 // --------------------- end of BASE-operand methods --------------------
-// --------------------- BigNumber-operand methods --------------------
+// --------------------- machine-word operands --------------------
+/*
+    uint64_t operands without building a BigNumber for them. Each kernel is one
+    pass over the limbs, the carry is kept in a 64-bit word:
+
+        AddWord: stops as soon as the carry is gone
+        MulWord: limb * v is up to 72 bits, so it is done in two 32-bit halves
+        DivWord: (r << 8) + limb must fit 64 bits -> v < 2^56 on the word path,
+                 bigger divisors go through DivRem
+*/
 
-BigNumber BigNumber::operator+ (const BigNumber& other) {
+BigNumber BigNumber::FromInt64(int64_t w)
+{
+    if (w < 0) throw std::underflow_error("Negative result");
+    return FromWord((uint64_t)w);
+}
 
-    if (coefs.empty() || (coefs.size()==1 && coefs[0]==0)) return other;
-    if (other.coefs.empty() || (other.coefs.size()==1 && other.coefs[0]==0)) return *this;
-    
+bool BigNumber::fits_uint64() const
+{
+    return getBitLength() <= 64;
+}
 
-    BigNumber res(0);
-    DBASE carry = 0;
-    size_t max_len = max(coefs.size(), other.coefs.size());
+uint64_t BigNumber::to_uint64() const
+{
+    if (!fits_uint64()) throw std::overflow_error("BigNumber does not fit in uint64_t");
 
-    for (size_t i = 0; i < max_len; i++)
-    {
-        DBASE a_val = (i < coefs.size()) ? DBASE(coefs[i]) : 0;
-        DBASE b_val = (i < other.coefs.size()) ? DBASE(other.coefs[i]) : 0;
-        
-        DBASE tmp = a_val + b_val + carry;
-        res.coefs.push_back(BASE(tmp));
-        carry = tmp >> BASE_SIZE;
+    uint64_t w = 0;
+    for (int i = min(coefs.size(), WORD_LIMBS) - 1; i >= 0; i--)
+        w = (w << BASE_SIZE) | coefs[i];
+    return w;
+}
+
+BigNumber& BigNumber::AddWord(uint64_t v)
+{
+    uint64_t carry = v;
+    for (size_t i = 0; i < coefs.size() && carry; i++) {
+        uint64_t sum = (carry & (BASENUM - 1)) + coefs[i];
+        coefs[i] = BASE(sum);
+        carry = (carry >> BASE_SIZE) + (sum >> BASE_SIZE);
     }
+    for (; carry; carry >>= BASE_SIZE)
+        coefs.push_back(BASE(carry));
 
-    if (carry != 0) res.coefs.push_back(BASE(carry));
-    int len = res.coefs.size();
-    while (len > 1 && res.coefs[len - 1] == 0) {
-        res.coefs.pop_back();
-        len--;
+    if (coefs.empty()) coefs.push_back(0);
+    invalidateHash();
+    return *this;
+}
+
+BigNumber& BigNumber::SubWord(uint64_t v)
+{
+    if (CompareWord(v) < 0) throw std::underflow_error("Negative result");
+
+    uint64_t borrow = v;
+    for (size_t i = 0; i < coefs.size() && borrow; i++) {
+        BASE lo = BASE(borrow);
+        borrow >>= BASE_SIZE;
+        if (coefs[i] < lo) borrow++;
+        coefs[i] = BASE(coefs[i] - lo);
     }
 
-    return res;
+    while (coefs.size() > 1 && coefs.back() == 0) coefs.pop_back();
+    invalidateHash();
+    return *this;
 }
 
-BigNumber& BigNumber::operator+= (const BigNumber& other){
-    *this = *this + other;
+BigNumber& BigNumber::MulWord(uint64_t v)
+{
+    if (v == 0 || IsZero()) {
+        coefs.assign(1, 0);
+        invalidateHash();
+        return *this;
+    }
+
+    const uint64_t v_lo = v & 0xffffffffULL;
+    const uint64_t v_hi = v >> 32;
+    uint64_t carry = 0;
+    for (size_t i = 0; i < coefs.size(); i++) {
+        // coefs[i] * v + carry = hi * 2^32 + lo, every part below 2^41
+        uint64_t lo = v_lo * coefs[i] + (carry & 0xffffffffULL);
+        uint64_t hi = v_hi * coefs[i] + (carry >> 32);
+        coefs[i] = BASE(lo);
+        carry = (hi << (32 - BASE_SIZE)) + (lo >> BASE_SIZE);
+    }
+    for (; carry; carry >>= BASE_SIZE)
+        coefs.push_back(BASE(carry));
+
+    invalidateHash();
     return *this;
 }
 
-BigNumber BigNumber::operator- (const BigNumber& other)
+uint64_t BigNumber::DivWord(uint64_t v)
 {
-    // small - BIG (!!!!)
-    if (*this < other) throw std::underflow_error("Error: Cannot subtract larger BigNumber");
-    // 1 - 1 = 0
-    if (*this == other) return BigNumber();
+    if (v == 0) throw invalid_argument("division by zero");
 
-    BigNumber res(0);
-    DBASE borrow = 0;
-    size_t max_len = coefs.size();
+    if (v >> (64 - BASE_SIZE)) {
+        BigNumber r;
+        *this = DivRem(FromWord(v), &r);
+        return r.to_uint64();
+    }
 
-    for (size_t i = 0; i < max_len; i++)
-    {
-        DBASE a_val = DBASE(coefs[i]);
-        DBASE b_val = (i < other.coefs.size()) ? DBASE(other.coefs[i]) : 0;
-        
-        DBASE tmp = a_val + BASENUM - b_val - borrow;
-        res.coefs.push_back(BASE(tmp));
-        borrow = 1 - (tmp >> BASE_SIZE);
+    uint64_t r = 0;
+    for (int i = (int)coefs.size() - 1; i >= 0; i--) {
+        uint64_t cur = (r << BASE_SIZE) | coefs[i];
+        coefs[i] = BASE(cur / v);
+        r = cur % v;
     }
 
-    // zero delete
-    while (res.coefs.size() > 1 && res.coefs.back() == 0) res.coefs.pop_back();
-    return res;
+    if (coefs.empty()) coefs.push_back(0);
+    while (coefs.size() > 1 && coefs.back() == 0) coefs.pop_back();
+    invalidateHash();
+    return r;
 }
 
-BigNumber& BigNumber::operator-= (const BigNumber& other){
-    *this = *this - other;
-    return *this;
+int BigNumber::CompareWord(uint64_t v) const
+{
+    if (!fits_uint64()) return 1;
+    uint64_t w = to_uint64();
+    return w == v ? 0 : (w > v ? 1 : -1);
 }
 
 
-BigNumber BigNumber::operator* (const BigNumber& other)
-{
-    // 0 * any = any * 0 = 0
-    if ((coefs.empty() || (coefs.size()==1 && coefs[0]==0)) || (other.coefs.empty() || (other.coefs.size()==1 && other.coefs[0]==0))) return BigNumber();
+// --------------------- fused multiply-accumulate --------------------
+/*
+    acc = acc + a * b as two operators makes a temporary for a * b and a second
+    one for the sum. The kernels below add (subtract) a * m straight into the
+    destination limbs in one pass:
 
-    int len_l = coefs.size();
-    int len_r = other.coefs.size();
-    int res_len = len_l + len_r;
+        r[0..n) += a[0..n) * m      -> returns the carry limb
+        r[0..n) -= a[0..n) * m      -> returns the borrow limb
+*/
 
-    BigNumber res;
-    res.coefs.resize(res_len, 0);
+static BASE AddMulLimbs(BASE* r, const BASE* a, size_t n, BASE m)
+{
+    DBASE carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        DBASE tmp = DBASE(a[i]) * DBASE(m) + DBASE(r[i]) + carry;   // <= 255*255 + 255 + 255
+        r[i] = BASE(tmp);
+        carry = tmp >> BASE_SIZE;
+    }
+    return BASE(carry);
+}
 
-    DBASE tmp;
-    BASE carry = 0;
+static BASE SubMulLimbs(BASE* r, const BASE* a, size_t n, BASE m)
+{
+    DBASE borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        DBASE prod = DBASE(a[i]) * DBASE(m) + borrow;
+        BASE lo = BASE(prod);
+        borrow = prod >> BASE_SIZE;
+        if (r[i] < lo) borrow++;
+        r[i] = BASE(r[i] - lo);
+    }
+    return BASE(borrow);
+}
+
+// adds c to r[0..n), returns the carry out of the top
+static BASE AddLimb(BASE* r, size_t n, BASE c)
+{
+    for (size_t i = 0; i < n && c; i++) {
+        DBASE tmp = DBASE(r[i]) + c;
+        r[i] = BASE(tmp);
+        c = BASE(tmp >> BASE_SIZE);
+    }
+    return c;
+}
+
+BigNumber& BigNumber::addmul(const BigNumber& a, const BASE& limb)
+{
+    // a may be *this: every limb is read before it is written, so no copy is needed
+    size_t a_len = a.coefs.size();
+    if (coefs.size() < a_len + 1) coefs.resize(a_len + 1, 0);
+
+    BASE carry = AddMulLimbs(coefs.data(), a.coefs.data(), a_len, limb);
+    if (AddLimb(coefs.data() + a_len, coefs.size() - a_len, carry)) coefs.push_back(1);
+
+    while (coefs.size() > 1 && coefs.back() == 0) coefs.pop_back();
+    invalidateHash();
+    return *this;
+}
+
+BigNumber& BigNumber::submul(const BigNumber& a, const BASE& limb)
+{
+    if (&a == this) {
+        BigNumber copy(a);
+        return submul(copy, limb);
+    }
+
+    size_t a_len = a.coefs.size();
+    size_t len = coefs.size();
+    if (len < a_len) coefs.resize(a_len, 0);
+
+    DBASE borrow = SubMulLimbs(coefs.data(), a.coefs.data(), a_len, limb);
+    for (size_t i = a_len; i < coefs.size() && borrow > 0; i++) {
+        DBASE tmp = DBASE(coefs[i]) + BASENUM - borrow;
+        coefs[i] = BASE(tmp);
+        borrow = 1 - (tmp >> BASE_SIZE);
+    }
+
+    if (borrow) {
+        // a * limb > *this: add it back (mod 256^size) and leave the number as it was
+        BASE carry = AddMulLimbs(coefs.data(), a.coefs.data(), a_len, limb);
+        AddLimb(coefs.data() + a_len, coefs.size() - a_len, carry);
+        coefs.resize(max(len, (size_t)1));
+        while (coefs.size() > 1 && coefs.back() == 0) coefs.pop_back();
+        throw std::underflow_error("Negative result");
+    }
+
+    while (coefs.size() > 1 && coefs.back() == 0) coefs.pop_back();
+    invalidateHash();
+    return *this;
+}
+
+// schoolbook rows added straight into *this
+static BASE AddLimbsAt(BASE* r, size_t n, const BASE* a, size_t na);
+static vector<BASE> MulKaratsubaLimbs(const BASE* a, size_t na, const BASE* b, size_t nb, size_t threshold);
+
+BigNumber& BigNumber::addmul(const BigNumber& a, const BigNumber& b)
+{
+    if (&a == this || &b == this) {
+        BigNumber copy(*this);
+        return addmul(&a == this ? copy : a, &b == this ? copy : b);
+    }
+
+    size_t a_len = a.coefs.size();
+    size_t b_len = b.coefs.size();
+    if (coefs.size() < a_len + b_len + 1) coefs.resize(a_len + b_len + 1, 0);
+
+    // long operands: Karatsuba product first, then one pass to add it in
+    size_t kt = thresholds().karatsuba_limbs;
+    if (a_len >= kt && b_len >= kt) {
+        vector<BASE> p = MulKaratsubaLimbs(a.coefs.data(), a_len, b.coefs.data(), b_len, kt);
+        if (AddLimbsAt(coefs.data(), coefs.size(), p.data(), p.size())) coefs.push_back(1);
+        while (coefs.size() > 1 && coefs.back() == 0) coefs.pop_back();
+        invalidateHash();
+        return *this;
+    }
+
+    for (size_t j = 0; j < b_len; j++) {
+        cancel_point();
+        if (b.coefs[j] == 0) continue;
+        BASE carry = AddMulLimbs(coefs.data() + j, a.coefs.data(), a_len, b.coefs[j]);
+        if (AddLimb(coefs.data() + j + a_len, coefs.size() - j - a_len, carry)) coefs.push_back(1);
+    }
+
+    while (coefs.size() > 1 && coefs.back() == 0) coefs.pop_back();
+    invalidateHash();
+    return *this;
+}
+
+BigNumber& BigNumber::muladd(const BASE& m, const BASE& c)
+{
+    DBASE carry = c;
+    for (size_t i = 0; i < coefs.size(); i++) {
+        DBASE tmp = DBASE(coefs[i]) * DBASE(m) + carry;
+        coefs[i] = BASE(tmp);
+        carry = tmp >> BASE_SIZE;
+    }
+    if (carry) coefs.push_back(BASE(carry));
+
+    if (coefs.empty()) coefs.push_back(0);
+    while (coefs.size() > 1 && coefs.back() == 0) coefs.pop_back();
+    invalidateHash();
+    return *this;
+}
+
+// --------------------- lazy expressions --------------------
+/*
+    lazy_eval_sum: dest = sum of sign * term + sum of sign * product
+        1. all plain terms in one pass: every limb position adds up the signed limbs
+           of every term in a wide accumulator, carry/borrow goes to the next position;
+        2. products are added into dest in place with addmul / submul.
+    With any subtraction around, positive products join step 1 as evaluated terms,
+    so a negative partial sum in step 1 always means a negative result.
+*/
+
+void lazy_eval_sum(BigNumber& dest, LazyTerms& t)
+{
+    bool has_neg = false;
+    for (auto& term : t.terms) if (term.sign < 0) has_neg = true;
+    for (auto& p : t.prods) if (p.sign < 0) has_neg = true;
+
+    // a result that may turn out negative is built aside: on underflow_error dest is unchanged
+    BigNumber scratch;
+    BigNumber& out = has_neg ? scratch : dest;
+
+    vector<LazyTerms::Prod> prods;
+    for (auto& p : t.prods) {
+        bool aliased = p.a == &dest || p.b == &dest;       // dest is overwritten by step 1
+        bool fused = !aliased && (p.sign > 0 ? !has_neg : p.b == nullptr);
+        if (fused) {
+            prods.push_back(p);
+            continue;
+        }
+        t.temps.emplace_back(*p.a);
+        if (p.b) t.temps.back() *= *p.b;
+        else t.temps.back() *= p.limb;
+        t.terms.push_back({ &t.temps.back(), p.sign });
+    }
+
+    // step 1: one carry pass, dest may be one of the terms (limb i is read before it is written)
+    size_t len = 1;
+    for (auto& term : t.terms) len = max(len, (size_t)term.x->getLength());
+    vector<const BASE*> src;
+    vector<size_t> src_len;
+    out.coefs.resize(max((size_t)out.coefs.size(), len), 0);
+    for (auto& term : t.terms) {
+        src.push_back(term.x->coefs.data());
+        src_len.push_back(term.x->coefs.size());
+    }
+
+    int64_t carry = 0;
+    for (size_t i = 0; i < len; i++) {
+        int64_t acc = carry;
+        for (size_t k = 0; k < src.size(); k++)
+            if (i < src_len[k]) acc += t.terms[k].sign * (int64_t)src[k][i];
+        out.coefs[i] = BASE(acc);
+        carry = acc >> BASE_SIZE;           // floor division, also for negative acc
+    }
+    out.coefs.resize(len);
+    while (carry > 0) {
+        out.coefs.push_back(BASE(carry));
+        carry >>= BASE_SIZE;
+    }
+    if (carry < 0) throw std::underflow_error("Negative result");
+    while (out.coefs.size() > 1 && out.coefs.back() == 0) out.coefs.pop_back();
+    out.invalidateHash();
+
+    // step 2: products straight into dest
+    for (auto& p : prods) {
+        if (p.b) out.addmul(*p.a, *p.b);
+        else if (p.sign > 0) out.addmul(*p.a, p.limb);
+        else out.submul(*p.a, p.limb);
+    }
+
+    if (has_neg) {
+        dest.coefs.swap(scratch.coefs);
+        dest.invalidateHash();
+    }
+}
+
+// dest = (a * b) mod m: operands are reduced first, the product is built in dest's
+// own storage and reduced there by the remainder-only Knuth path (no quotient digits stored)
+void lazy_eval_mulmod(BigNumber& dest, const BigNumber& a, const BigNumber& b, const BigNumber& m)
+{
+    if (&dest == &a || &dest == &b || &dest == &m) {
+        BigNumber res;
+        lazy_eval_mulmod(res, a, b, m);
+        dest = res;
+        return;
+    }
+
+    BigNumber mod(m);
+    BigNumber ra, rb;
+    const BigNumber* x = &a;
+    const BigNumber* y = &b;
+    if (a >= m) { ra = BigNumber(a) % mod; x = &ra; }
+    if (b >= m) { rb = BigNumber(b) % mod; y = &rb; }
+
+    dest.coefs.assign(1, 0);
+    dest.addmul(*x, *y);
+    dest.DivRem(mod, &dest, false);
+    dest.invalidateHash();
+}
+
+
+// --------------------- Karatsuba multiplication --------------------
+/*
+    x = x1 * B^k + x0,  y = y1 * B^k + y0   (B = 256)
+
+    x * y = z2 * B^2k + z1 * B^k + z0, where
+        z0 = x0 * y0,  z2 = x1 * y1,  z1 = (x0 + x1)(y0 + y1) - z0 - z2
+
+    three half-size products instead of four. Below thresholds().karatsuba_limbs
+    the schoolbook rows are faster.
+*/
+
+static void MulSchoolbookLimbs(const BASE* a, size_t na, const BASE* b, size_t nb, BASE* r)
+{
+    fill(r, r + na + nb, 0);
+    for (size_t j = 0; j < nb; j++) {
+        cancel_point();
+        r[j + na] = b[j] ? AddMulLimbs(r + j, a, na, b[j]) : 0;
+    }
+}
+
+// r[0..n) += a[0..na), na <= n; returns the carry out of r[n - 1]
+static BASE AddLimbsAt(BASE* r, size_t n, const BASE* a, size_t na)
+{
+    while (na > 0 && a[na - 1] == 0) na--;
+    return AddLimb(r + na, n - na, AddMulLimbs(r, a, na, 1));
+}
+
+// r[0..n) -= a[0..na), na <= n; the caller guarantees r >= a
+static void SubLimbsAt(BASE* r, size_t n, const BASE* a, size_t na)
+{
+    BASE borrow = SubMulLimbs(r, a, na, 1);
+    for (size_t i = na; i < n && borrow; i++) {
+        borrow = r[i] == 0;
+        r[i]--;
+    }
+}
+
+static vector<BASE> MulKaratsubaLimbs(const BASE* a, size_t na, const BASE* b, size_t nb, size_t threshold)
+{
+    vector<BASE> r(na + nb, 0);
+    if (na < threshold || nb < threshold) {
+        MulSchoolbookLimbs(a, na, b, nb, r.data());
+        return r;
+    }
+
+    // unbalanced: cut the longer factor into pieces as long as the shorter one
+    if (na >= 2 * nb || nb >= 2 * na) {
+        if (na < nb) { swap(a, b); swap(na, nb); }
+        for (size_t off = 0; off < na; off += nb) {
+            size_t len = min(nb, na - off);
+            vector<BASE> part = MulKaratsubaLimbs(a + off, len, b, nb, threshold);
+            AddLimbsAt(r.data() + off, r.size() - off, part.data(), part.size());
+        }
+        return r;
+    }
+
+    size_t k = max(na, nb) / 2;
+    vector<BASE> z0 = MulKaratsubaLimbs(a, k, b, k, threshold);
+    vector<BASE> z2 = MulKaratsubaLimbs(a + k, na - k, b + k, nb - k, threshold);
+
+    vector<BASE> sa(max(k, na - k) + 1, 0), sb(max(k, nb - k) + 1, 0);
+    copy(a, a + k, sa.begin());
+    AddLimbsAt(sa.data(), sa.size(), a + k, na - k);
+    copy(b, b + k, sb.begin());
+    AddLimbsAt(sb.data(), sb.size(), b + k, nb - k);
+
+    vector<BASE> z1 = MulKaratsubaLimbs(sa.data(), sa.size(), sb.data(), sb.size(), threshold);
+    SubLimbsAt(z1.data(), z1.size(), z0.data(), z0.size());     // z1 >= z0 + z2
+    SubLimbsAt(z1.data(), z1.size(), z2.data(), z2.size());
+
+    AddLimbsAt(r.data(), r.size(), z0.data(), z0.size());
+    AddLimbsAt(r.data() + 2 * k, r.size() - 2 * k, z2.data(), z2.size());
+    AddLimbsAt(r.data() + k, r.size() - k, z1.data(), z1.size());
+    return r;
+}
+
+
+// --------------------- BigNumber-operand methods --------------------
+
+BigNumber BigNumber::operator+ (const BigNumber& other) {
+
+    if (coefs.empty() || (coefs.size()==1 && coefs[0]==0)) return other;
+    if (other.coefs.empty() || (other.coefs.size()==1 && other.coefs[0]==0)) return *this;
+    
+
+    BigNumber res(0);
+    DBASE carry = 0;
+    size_t max_len = max(coefs.size(), other.coefs.size());
+
+    for (size_t i = 0; i < max_len; i++)
+    {
+        DBASE a_val = (i < coefs.size()) ? DBASE(coefs[i]) : 0;
+        DBASE b_val = (i < other.coefs.size()) ? DBASE(other.coefs[i]) : 0;
+        
+        DBASE tmp = a_val + b_val + carry;
+        res.coefs.push_back(BASE(tmp));
+        carry = tmp >> BASE_SIZE;
+    }
+
+    if (carry != 0) res.coefs.push_back(BASE(carry));
+    int len = res.coefs.size();
+    while (len > 1 && res.coefs[len - 1] == 0) {
+        res.coefs.pop_back();
+        len--;
+    }
+
+    return res;
+}
+
+BigNumber& BigNumber::operator+= (const BigNumber& other){
+    *this = *this + other;
+    return *this;
+}
+
+BigNumber BigNumber::operator- (const BigNumber& other)
+{
+    // small - BIG (!!!!)
+    if (*this < other) throw std::underflow_error("Error: Cannot subtract larger BigNumber");
+    // 1 - 1 = 0
+    if (*this == other) return BigNumber();
+
+    BigNumber res(0);
+    DBASE borrow = 0;
+    size_t max_len = coefs.size();
+
+    for (size_t i = 0; i < max_len; i++)
+    {
+        DBASE a_val = DBASE(coefs[i]);
+        DBASE b_val = (i < other.coefs.size()) ? DBASE(other.coefs[i]) : 0;
+        
+        DBASE tmp = a_val + BASENUM - b_val - borrow;
+        res.coefs.push_back(BASE(tmp));
+        borrow = 1 - (tmp >> BASE_SIZE);
+    }
+
+    // zero delete
+    while (res.coefs.size() > 1 && res.coefs.back() == 0) res.coefs.pop_back();
+    return res;
+}
+
+BigNumber& BigNumber::operator-= (const BigNumber& other){
+    *this = *this - other;
+    return *this;
+}
+
+
+BigNumber BigNumber::operator* (const BigNumber& other)
+{
+    // 0 * any = any * 0 = 0
+    if ((coefs.empty() || (coefs.size()==1 && coefs[0]==0)) || (other.coefs.empty() || (other.coefs.size()==1 && other.coefs[0]==0))) return BigNumber();
+
+    int len_l = coefs.size();
+    int len_r = other.coefs.size();
+    int res_len = len_l + len_r;
+
+    BigNumber res;
+    size_t kt = thresholds().karatsuba_limbs;
+    if ((size_t)len_l >= kt && (size_t)len_r >= kt) {
+        res.coefs = MulKaratsubaLimbs(coefs.data(), len_l, other.coefs.data(), len_r, kt);
+        while (res.coefs.size() > 1 && res.coefs.back() == 0) res.coefs.pop_back();
+        return res;
+    }
+    res.coefs.resize(res_len, 0);
+
+    DBASE tmp;
+    BASE carry = 0;
 
     for (int j = 0; j < len_r; j++)
     {
+        cancel_point();
         if (other.coefs[j] != 0)
         {
             carry = 0;
@@ -518,6 +1509,12 @@ BigNumber& BigNumber::operator*= (const BigNumber& other)
 
 
 BigNumber BigNumber::operator/ (const BigNumber& other)
+{
+    return DivRem(other, nullptr);
+}
+
+// Частное u / v; если rem != nullptr, туда же пишется остаток (rem может совпадать с *this)
+BigNumber BigNumber::DivRem(const BigNumber& other, BigNumber* rem, bool quotient) const
 {
 
     BigNumber zeroNum;
@@ -532,15 +1529,24 @@ BigNumber BigNumber::operator/ (const BigNumber& other)
         cout << "Error: in operator/ (other / 0)!\n";
         exit(-3);
     }
-    if (sizeL == 0) return zeroNum;    // 0 / v = 0
-    if (sizeR == 1)                      // деление на одну цифру (оптимизация)
-        return *this / other.coefs[0];
-    if (*this < other) return zeroNum;   // если делимое < делитель -> 0
+    if (sizeL == 0) {                    // 0 / v = 0
+        if (rem) *rem = zeroNum;
+        return zeroNum;
+    }
+    if (sizeR == 1) {                    // деление на одну цифру (оптимизация)
+        if (rem) *rem = u % other.coefs[0];
+        return quotient ? u / other.coefs[0] : zeroNum;
+    }
+    if (*this < other) {                 // если делимое < делитель -> 0
+        if (rem) *rem = u;
+        return zeroNum;
+    }
     if (*this == other) {                // если равны -> 1
         BigNumber one;
         one.coefs.clear();
         one.coefs.push_back(1);
-        return one;
+        if (rem) *rem = zeroNum;
+        return quotient ? one : zeroNum;
     }
 
 
@@ -556,18 +1562,17 @@ BigNumber BigNumber::operator/ (const BigNumber& other)
     u = u * d;
     v = v * d;
 
+    // u держим длиной m + n + 1 до конца: вычитание идёт на месте, по модулю 256^(i+n+1)
+    u.coefs.resize(sizeL + 1, 0);
 
-    if (u.coefs.size() == sizeL) u.coefs.push_back(0);
 
-
-    BigNumber q;
-    q.coefs.resize(m + 1, 0);
+    BigNumber q;                         // остаётся 0, если частное не нужно
+    if (quotient) q.coefs.resize(m + 1, 0);
 
 
     for (int i = m; i >= 0; --i)
     {
-
-        while (i + n >= (int)u.coefs.size()) u.coefs.push_back(0);
+        cancel_point();
 
         // Пробное частное q_hat: берем две старшие цифры u_{i+n} и u_{i+n-1}
         DBASE u2 = DBASE(u.coefs[i + n]);
@@ -580,40 +1585,757 @@ BigNumber BigNumber::operator/ (const BigNumber& other)
         DBASE rhat = ( (u2 << BASE_SIZE) + u1 ) % v1;
 
 
-        while (qhat == b || (qhat * v2) > ((rhat << BASE_SIZE) + u0)) {
+        while (qhat >= b || (qhat * v2) > ((rhat << BASE_SIZE) + u0)) {
             qhat--;
             rhat += v1;
             if (rhat >= b) break; // защита, если rhat превысил базу
         }
 
 
-        BigNumber t = v * (BASE)qhat;
-        t = t.Shift(i);
+        // u[i..i+n] -= q_hat * v  (одним проходом, без временного t)
+        BASE borrow = SubMulLimbs(&u.coefs[i], &v.coefs[0], n, (BASE)qhat);
+        bool negative = u.coefs[i + n] < borrow;
+        u.coefs[i + n] -= borrow;
 
-
-        if (u < t) {
+        // q_hat оказался на 1 больше: возвращаем v обратно
+        if (negative) {
             qhat--;
-            t = v * (BASE)qhat;
-            t = t.Shift(i);
-
-            while (u < t) {
-                qhat--;
-                t = v * (BASE)qhat;
-                t = t.Shift(i);
-            }
+            u.coefs[i + n] += AddMulLimbs(&u.coefs[i], &v.coefs[0], n, 1);
         }
 
-        u = u - t;
-        q.coefs[i] = (BASE)qhat;
+        if (quotient) q.coefs[i] = (BASE)qhat;
     }
 
 
 
     while (q.coefs.size() > 1 && q.coefs.back() == 0) q.coefs.pop_back();
 
+    // остаток = u / d (снимаем нормализацию)
+    if (rem) {
+        while (u.coefs.size() > 1 && u.coefs.back() == 0) u.coefs.pop_back();
+        *rem = u / d;
+    }
+
     return q;
 }
 
+BigNumber& BigNumber::operator/= (const BigNumber& other)
+{
+    *this = *this / other;
+    return *this;
+}
+
+// the remainder is what is left of u after the Knuth division; q is not built
+BigNumber BigNumber::operator% (const BigNumber& other)
+{
+    BigNumber r;
+    DivRem(other, &r, false);
+    return r;
+}
+
+BigNumber& BigNumber::operator%= (const BigNumber& other)
+{
+    *this = *this % other;
+    return *this;
+}
+
+// Shift by whole limbs: bits > 0 multiplies by 256^bits, bits < 0 divides by 256^(-bits)
+BigNumber BigNumber::Shift(int bits)
+{
+    BigNumber res(*this);
+    if (bits > 0)
+        res.coefs.insert(res.coefs.begin(), bits, 0);
+    else if (bits < 0)
+        res.coefs.erase(res.coefs.begin(), res.coefs.begin() + min((size_t)(-bits), res.coefs.size()));
+
+    if (res.coefs.empty()) res.coefs.push_back(0);
+    while (res.coefs.size() > 1 && res.coefs.back() == 0) res.coefs.pop_back();
+    return res;
+}
+
+unsigned int BigNumber::getBitLength() const
+{
+    int len = coefs.size();
+    while (len > 0 && coefs[len - 1] == 0) len--;
+    if (len == 0) return 0;
+
+    unsigned int bits = (len - 1) * BASE_SIZE;
+    for (BASE top = coefs[len - 1]; top; top >>= 1) bits++;
+    return bits;
+}
+
+bool BigNumber::testBit(unsigned int i) const
+{
+    if (i / BASE_SIZE >= coefs.size()) return false;
+    return (coefs[i / BASE_SIZE] >> (i % BASE_SIZE)) & 1;
+}
+
+// Horner from the top limb: r = (r * 256 + coef) mod m
+// Horner over the limbs while (r << 8) + limb fits 64 bits (m < 2^56), as in DivWord;
+// larger m use the remainder-only Knuth path
+uint64_t BigNumber::ModWord(uint64_t m) const
+{
+    if (m == 0) throw invalid_argument("ModWord: division by zero");
+
+    if (m >> (64 - BASE_SIZE)) {
+        BigNumber r;
+        DivRem(FromWord(m), &r, false);
+        return r.to_uint64();
+    }
+
+    uint64_t r = 0;
+    for (int i = (int)coefs.size() - 1; i >= 0; i--)
+        r = ((r << BASE_SIZE) | coefs[i]) % m;
+    return r;
+}
+
+BigNumber BigNumber::FromWord(unsigned long long w)
+{
+    BigNumber res(0);
+    do {
+        res.coefs.push_back(BASE(w));
+        w >>= BASE_SIZE;
+    } while (w != 0);
+    return res;
+}
+
+
+// ----------  product trees  ------------
+/*
+    Folding a list with *= makes every step a (big x small) multiply.
+    A balanced tree multiplies numbers of about the same length:
+
+                 f0*f1*f2*f3
+                /           \
+            f0*f1           f2*f3
+            /   \           /   \
+          f0    f1        f2    f3
+
+    Small factors are first packed together into one machine word,
+    so the leaves are already several limbs long.
+*/
+
+// sieve of Eratosthenes: all primes <= limit
+static vector<unsigned int> SmallPrimes(unsigned int limit)
+{
+    vector<unsigned int> primes;
+    if (limit < 2) return primes;
+
+    vector<bool> composite(limit + 1, false);
+    for (unsigned long long i = 2; i <= limit; i++) {
+        if (composite[i]) continue;
+        primes.push_back((unsigned int)i);
+        for (unsigned long long j = i * i; j <= limit; j += i)
+            composite[j] = true;
+    }
+    return primes;
+}
+
+// balanced product of f[lo..hi); limbs[i] = total length of f[0..i).
+// Big enough halves are multiplied on two threads (thresholds().parallel_limbs),
+// at most `splits` levels deep, so no more than 2^splits threads run at once.
+static BigNumber ProductTree(const vector<BigNumber>& f, size_t lo, size_t hi, const vector<size_t>& limbs, int splits)
+{
+    if (hi - lo == 1) return f[lo];
+    size_t mid = lo + (hi - lo) / 2;
+
+    if (splits > 0 && limbs[hi] - limbs[lo] >= thresholds().parallel_limbs) {
+        future<BigNumber> left = async(launch::async, [&] { return ProductTree(f, lo, mid, limbs, splits - 1); });
+        BigNumber right = ProductTree(f, mid, hi, limbs, splits - 1);
+        return left.get() * right;
+    }
+    return ProductTree(f, lo, mid, limbs, splits) * ProductTree(f, mid, hi, limbs, splits);
+}
+
+// product of f[lo..hi); parallel splits limited to log2(hardware threads)
+static BigNumber ProductTree(const vector<BigNumber>& f, size_t lo, size_t hi)
+{
+    vector<size_t> limbs(f.size() + 1, 0);
+    for (size_t i = 0; i < f.size(); i++) limbs[i + 1] = limbs[i] + f[i].getLength();
+
+    int splits = 0;
+    for (unsigned hw = thread::hardware_concurrency(); hw > 1; hw >>= 1) splits++;
+    return ProductTree(f, lo, hi, limbs, splits);
+}
+
+// pack word factors into leaves that fit one machine word, then multiply the leaves as a tree
+static BigNumber ProductOfWords(const vector<unsigned long long>& words)
+{
+    vector<BigNumber> leaves;
+    unsigned long long acc = 1;
+
+    for (unsigned long long w : words) {
+        if (w == 0) return BigNumber();
+        if (acc > ULLONG_MAX / w) {
+            leaves.push_back(BigNumber::FromWord(acc));
+            acc = 1;
+        }
+        acc *= w;
+    }
+    if (acc != 1 || leaves.empty()) leaves.push_back(BigNumber::FromWord(acc));
+
+    return ProductTree(leaves, 0, leaves.size());
+}
+
+BigNumber product(const vector<BigNumber>& factors)
+{
+    if (factors.empty()) return BigNumber::FromWord(1);
+
+    // single-limb factors are packed into words, longer ones go to the tree as they are
+    vector<BigNumber> leaves;
+    unsigned long long acc = 1;
+    bool packed = false;
+
+    for (size_t i = 0; i < factors.size(); i++) {
+        if (factors[i].coefs.size() > 1) {
+            leaves.push_back(factors[i]);
+            continue;
+        }
+        BASE f = factors[i].coefs.empty() ? 0 : factors[i].coefs[0];
+        if (f == 0) return BigNumber();
+        if (acc > ULLONG_MAX / f) {
+            leaves.push_back(BigNumber::FromWord(acc));
+            acc = 1;
+        }
+        acc *= f;
+        packed = true;
+    }
+    if (packed && acc != 1) leaves.push_back(BigNumber::FromWord(acc));
+    if (leaves.empty()) return BigNumber::FromWord(1);
+
+    return ProductTree(leaves, 0, leaves.size());
+}
+
+BigNumber factorial(unsigned int n)
+{
+    vector<unsigned long long> words;
+    for (unsigned long long i = 2; i <= n; i++) words.push_back(i);
+    return ProductOfWords(words);
+}
+
+// n! / (k! (n-k)!) from its prime factorization (Legendre's formula),
+// so no big division is needed at all
+BigNumber binomial(unsigned int n, unsigned int k)
+{
+    if (k > n) return BigNumber();
+    if (k > n - k) k = n - k;
+
+    vector<unsigned long long> words;
+    vector<unsigned int> primes = SmallPrimes(n);
+    for (unsigned int p : primes) {
+        unsigned int e = 0;
+        for (unsigned long long pk = p; pk <= n; pk *= p)
+            e += n / pk - k / pk - (n - k) / pk;
+        for (unsigned int j = 0; j < e; j++) words.push_back(p);
+    }
+    return ProductOfWords(words);
+}
+
+BigNumber primorial(unsigned int n)
+{
+    vector<unsigned int> primes = SmallPrimes(n);
+    vector<unsigned long long> words(primes.begin(), primes.end());
+    return ProductOfWords(words);
+}
+
+// x mod m_i for every modulus: reduce x by the product of the moduli once,
+// then push the remainders down the tree, each level working with shorter numbers
+vector<BigNumber> remainder_tree(const BigNumber& x, const vector<BigNumber>& moduli)
+{
+    vector<BigNumber> res;
+    if (moduli.empty()) return res;
+
+    // levels[0] = moduli, levels.back() = product of all of them
+    vector<vector<BigNumber>> levels(1, moduli);
+    while (levels.back().size() > 1) {
+        vector<BigNumber>& cur = levels.back();
+        vector<BigNumber> next;
+        for (size_t i = 0; i + 1 < cur.size(); i += 2)
+            next.push_back(cur[i] * cur[i + 1]);
+        if (cur.size() % 2) next.push_back(cur.back());
+        levels.push_back(next);
+    }
+
+    BigNumber root(x);
+    res.push_back(root % levels.back()[0]);
+    for (int l = (int)levels.size() - 2; l >= 0; l--) {
+        vector<BigNumber> next;
+        for (size_t i = 0; i < levels[l].size(); i++)
+            next.push_back(res[i / 2] % levels[l][i]);
+        res = next;
+    }
+    return res;
+}
+
+
+// ----------  random numbers  ------------
+
+// splitmix64 spreads one 64-bit seed over the whole xoshiro state
+void RandomEngine::Seed(uint64_t seed)
+{
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        s[i] = z ^ (z >> 31);
+    }
+}
+
+uint64_t RandomEngine::Next()
+{
+    uint64_t res = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return res;
+}
+
+void RandomEngine::Fill(BASE* buf, size_t n)
+{
+    const size_t per_word = sizeof(uint64_t) / sizeof(BASE);
+    size_t i = 0;
+    for (; i + per_word <= n; i += per_word) {
+        uint64_t w = Next();
+        for (size_t j = 0; j < per_word; j++, w >>= BASE_SIZE)
+            buf[i + j] = BASE(w);
+    }
+    if (i < n) {
+        uint64_t w = Next();
+        for (; i < n; i++, w >>= BASE_SIZE)
+            buf[i] = BASE(w);
+    }
+}
+
+// every thread gets its own engine, seeded from random_device on first use
+RandomEngine& thread_engine()
+{
+    thread_local RandomEngine eng(((uint64_t)random_device{}() << 32) ^ random_device{}());
+    return eng;
+}
+
+void seed_random(uint64_t seed)
+{
+    thread_engine().Seed(seed);
+}
+
+BigNumber random_bits(unsigned int n, RandomEngine& eng)
+{
+    if (n == 0) return BigNumber();
+
+    unsigned int len = (n + BASE_SIZE - 1) / BASE_SIZE;
+    BigNumber res(0);
+    res.coefs.resize(len);
+    eng.Fill(res.coefs.data(), len);
+
+    // cut the top limb down to the requested number of bits
+    unsigned int top_bits = n - (len - 1) * BASE_SIZE;
+    if (top_bits < BASE_SIZE) res.coefs[len - 1] &= BASE((1u << top_bits) - 1);
+
+    while (res.coefs.size() > 1 && res.coefs.back() == 0) res.coefs.pop_back();
+    return res;
+}
+
+// rejection sampling: draw as many bits as bound has and retry while the value is too big
+// (each try succeeds with probability > 1/2)
+BigNumber random_below(const BigNumber& bound, RandomEngine& eng)
+{
+    unsigned int bits = bound.getBitLength();
+    if (bits == 0) throw invalid_argument("random_below: bound must be positive");
+
+    BigNumber res = random_bits(bits, eng);
+    while (res >= bound) res = random_bits(bits, eng);
+    return res;
+}
+
+BigNumber random_range(const BigNumber& lo, const BigNumber& hi, RandomEngine& eng)
+{
+    if (!(lo < hi)) throw invalid_argument("random_range: empty range (lo >= hi)");
+
+    BigNumber low(lo), high(hi);
+    return random_below(high - low, eng) + low;
+}
+
+
+// ----------  primality  ------------
+/*
+    is_probable_prime(n):
+        1. trial division by all primes < SIEVE_LIMIT. Instead of dividing the
+           big n by every prime, n is reduced once modulo their product
+           P = 2*3*5*...; the short remainder n mod P is then divided by words.
+        2. Miller-Rabin with base 2 and (rounds - 1) random bases.
+
+    next_prime(n) sieves a whole window [start, start + width) with the same
+    primes and runs Miller-Rabin only on the few survivors.
+*/
+
+#define SIEVE_LIMIT 2000
+
+static const vector<unsigned int>& SievePrimes()
+{
+    static const vector<unsigned int> primes = SmallPrimes(SIEVE_LIMIT);
+    return primes;
+}
+
+static const BigNumber& SievePrimesProduct()
+{
+    static const BigNumber P = primorial(SIEVE_LIMIT);
+    return P;
+}
+
+// square-and-multiply from the top bit of exp
+BigNumber powmod(const BigNumber& base, const BigNumber& exp, const BigNumber& mod)
+{
+    if (mod.getBitLength() == 0) throw invalid_argument("powmod: modulus is zero");
+
+    BigNumber m(mod);
+    BigNumber b = BigNumber(base) % m;
+    BigNumber res = BigNumber::FromWord(1) % m;
+
+    for (int i = (int)exp.getBitLength() - 1; i >= 0; i--) {
+        res = (res * res) % m;
+        if (exp.testBit(i)) res = (res * b) % m;
+    }
+    return res;
+}
+
+// one Miller-Rabin round, n - 1 = d * 2^s
+static bool MillerRabinRound(BigNumber& n, BigNumber& n_1, const BigNumber& d, unsigned int s, const BigNumber& a)
+{
+    BigNumber one = BigNumber::FromWord(1);
+    BigNumber x = powmod(a, d, n);
+    if (x == one || x == n_1) return true;
+
+    for (unsigned int r = 1; r < s; r++) {
+        x = (x * x) % n;
+        if (x == n_1) return true;
+        if (x == one) return false;
+    }
+    return false;
+}
+
+bool is_probable_prime(const BigNumber& n, int rounds)
+{
+    if (n.getBitLength() < 2) return false;       // 0, 1
+
+    // trial division through n mod P
+    BigNumber num(n);
+    BigNumber g = num % SievePrimesProduct();
+    for (unsigned int p : SievePrimes())
+        if (g.ModWord(p) == 0) return num == BigNumber::FromWord(p);
+
+    // no factor below SIEVE_LIMIT and n < SIEVE_LIMIT^2
+    if (num.getBitLength() <= 21) return true;
+
+    BigNumber n_1 = num - (BASE)1;
+    BigNumber d = n_1;
+    unsigned int s = 0;
+    while (!d.testBit(0)) {
+        d /= (BASE)2;
+        s++;
+    }
+
+    if (!MillerRabinRound(num, n_1, d, s, BigNumber::FromWord(2))) return false;
+
+    BigNumber two = BigNumber::FromWord(2);
+    for (int i = 1; i < rounds; i++) {
+        BigNumber a = random_range(two, n_1);     // a in [2, n - 2]
+        if (!MillerRabinRound(num, n_1, d, s, a)) return false;
+    }
+    return true;
+}
+
+vector<unsigned int> sieve_candidates(const BigNumber& start, unsigned int width)
+{
+    vector<bool> composite(width, false);
+    BigNumber st(start);
+    BigNumber g = st % SievePrimesProduct();
+
+    // a window starting below SIEVE_LIMIT contains the sieving primes themselves
+    unsigned long long start_word = 0;
+    bool small_start = st.getBitLength() <= 32;
+    if (small_start)
+        for (int bit = (int)st.getBitLength() - 1; bit >= 0; bit--)
+            start_word = (start_word << 1) | st.testBit(bit);
+
+    for (unsigned int p : SievePrimes()) {
+        unsigned int r = (unsigned int)g.ModWord(p);
+        unsigned int first = r ? p - r : 0;     // offset of the first multiple of p
+        for (unsigned long long i = first; i < width; i += p)
+            composite[i] = true;
+
+        if (small_start && p >= start_word && p - start_word < width)
+            composite[p - start_word] = false;
+    }
+
+    // 0 and 1 are not primes either
+    unsigned int i = st.getBitLength() == 0 ? 2 : (st.getBitLength() == 1 ? 1 : 0);
+
+    vector<unsigned int> res;
+    for (; i < width; i++)
+        if (!composite[i]) res.push_back(i);
+    return res;
+}
+
+BigNumber next_prime(const BigNumber& n)
+{
+    BigNumber start = BigNumber(n) + (BASE)1;
+    unsigned int width = max(1024u, 2 * start.getBitLength());
+
+    while (true) {
+        for (unsigned int off : sieve_candidates(start, width)) {
+            BigNumber c = start + off;
+            if (is_probable_prime(c)) return c;
+        }
+        start += width;
+    }
+}
+
+
+// ----------  asynchronous computation  ------------
+
+thread_local const CancelToken* current_cancel_token = nullptr;
+
+CancelToken CancelToken::WithDeadline(chrono::steady_clock::time_point deadline)
+{
+    CancelToken tok;
+    tok.state->has_deadline = true;
+    tok.state->deadline = deadline;
+    return tok;
+}
+
+CancelToken CancelToken::WithTimeout(chrono::milliseconds timeout)
+{
+    return WithDeadline(chrono::steady_clock::now() + timeout);
+}
+
+bool CancelToken::IsCancelled() const
+{
+    if (state->cancelled.load(memory_order_relaxed)) return true;
+    return state->has_deadline && chrono::steady_clock::now() >= state->deadline;
+}
+
+// the flag is one relaxed load, the clock is read only every 16th call
+inline void cancel_point()
+{
+    static thread_local unsigned tick = 0;
+    const CancelToken* tok = current_cancel_token;
+    if (!tok) return;
+    if (tok->state->cancelled.load(memory_order_relaxed)) throw OperationCancelled();
+    if ((++tick & 15) == 0 && tok->state->has_deadline && chrono::steady_clock::now() >= tok->state->deadline)
+        throw OperationCancelled();
+}
+
+AsyncExecutor::AsyncExecutor(unsigned threads, size_t capacity) : capacity(max(capacity, (size_t)1))
+{
+    for (unsigned i = 0; i < max(threads, 1u); i++)
+        workers.emplace_back(&AsyncExecutor::WorkerLoop, this);
+}
+
+AsyncExecutor::~AsyncExecutor()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+    }
+    not_empty.notify_all();
+    not_full.notify_all();
+    for (thread& t : workers) t.join();
+}
+
+void AsyncExecutor::WorkerLoop()
+{
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(mtx);
+            not_empty.wait(lock, [this] { return !tasks.empty() || stopping; });
+            if (tasks.empty()) return;      // stopping and nothing left
+            task = move(tasks.front());
+            tasks.pop_front();
+        }
+        not_full.notify_one();
+        task();                             // exceptions are stored in the task's future
+    }
+}
+
+AsyncExecutor& default_executor()
+{
+    static AsyncExecutor ex;
+    return ex;
+}
+
+future<BigNumber> async_mul(const BigNumber& a, const BigNumber& b, CancelToken tok, AsyncExecutor& ex)
+{
+    return ex.Submit([x = BigNumber(a), y = BigNumber(b)]() mutable { return x * y; }, tok);
+}
+
+future<BigNumber> async_div(const BigNumber& a, const BigNumber& b, CancelToken tok, AsyncExecutor& ex)
+{
+    return ex.Submit([x = BigNumber(a), y = BigNumber(b)]() mutable { return x / y; }, tok);
+}
+
+future<BigNumber> async_mod(const BigNumber& a, const BigNumber& b, CancelToken tok, AsyncExecutor& ex)
+{
+    return ex.Submit([x = BigNumber(a), y = BigNumber(b)]() mutable { return x % y; }, tok);
+}
+
+future<string> async_to_string(const BigNumber& a, CancelToken tok, AsyncExecutor& ex)
+{
+    return ex.Submit([a]() { return a.ToDecimal(); }, tok);
+}
+
+
+// ----------  algorithm thresholds  ------------
+Thresholds& thresholds()
+{
+    static Thresholds t = [] {
+        Thresholds d;
+        if (thread::hardware_concurrency() <= 1) d.parallel_limbs = SIZE_MAX;   // nothing to run the second half on
+        const char* path = getenv("BIGNUMBER_PROFILE");
+        load_thresholds(path ? path : BIGNUMBER_PROFILE_PATH, d);
+        return d;
+    }();
+    return t;
+}
+
+/*
+    Profile file, one "key = value" per line, '#' starts a comment:
+
+        karatsuba_limbs = 48
+        dc_radix_limbs = 256
+        parallel_limbs = off        # off: never split onto threads
+
+    Unknown keys and unreadable values (anything not starting with a digit) are
+    skipped, so an old profile still loads.
+*/
+bool load_thresholds(const string& path, Thresholds& t)
+{
+    ifstream in(path);
+    if (!in) return false;
+
+    string line;
+    while (getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        size_t eq = line.find('=');
+        if (eq == string::npos) continue;
+
+        auto trim = [](string x) {
+            x.erase(0, x.find_first_not_of(" \t\r"));
+            x.erase(x.find_last_not_of(" \t\r") + 1);
+            return x;
+        };
+        string key = trim(line.substr(0, eq)), val = trim(line.substr(eq + 1));
+
+        size_t v;
+        if (val == "off") v = SIZE_MAX;
+        else {
+            if (val.empty() || !isdigit((unsigned char)val[0])) continue;    // stoull would wrap "-5" around
+            try { v = stoull(val); } catch (const exception&) { continue; }
+        }
+
+        if (key == "karatsuba_limbs") t.karatsuba_limbs = max<size_t>(v, 4);   // Karatsuba needs halves of at least 2 limbs
+        else if (key == "dc_radix_limbs") t.dc_radix_limbs = max<size_t>(v, 2);
+        else if (key == "parallel_limbs") t.parallel_limbs = max<size_t>(v, 2);
+    }
+    return true;
+}
+
+bool save_thresholds(const string& path, const Thresholds& t)
+{
+    ofstream out(path);
+    if (!out) return false;
+
+    auto val = [](size_t v) { return v == SIZE_MAX ? string("off") : to_string(v); };
+    out << "# BigNumber thresholds, written by --tune (in limbs of " << BASE_SIZE << " bits)" << endl;
+    out << "karatsuba_limbs = " << val(t.karatsuba_limbs) << endl;
+    out << "dc_radix_limbs = " << val(t.dc_radix_limbs) << endl;
+    out << "parallel_limbs = " << val(t.parallel_limbs) << endl;
+    return bool(out);
+}
+
+// best of several runs, each repeated until it lasts at least ~2 ms
+static double BestTime(const function<void()>& f)
+{
+    double best = 1e30;
+    for (int round = 0; round < 5; round++) {
+        int reps = 0;
+        auto start = chrono::steady_clock::now();
+        double elapsed;
+        do {
+            f();
+            reps++;
+            elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        } while (elapsed < 0.002);
+        best = min(best, elapsed / reps);
+    }
+    return best;
+}
+
+/*
+    Each threshold is the smallest size at which one level of the faster
+    algorithm (recursing into the old one) beats the old one outright.
+    The size lists stop where waiting longer would not change the answer.
+*/
+Thresholds tune_thresholds(ostream& log)
+{
+    Thresholds& cur = thresholds();
+    Thresholds saved = cur, best;
+
+    // Karatsuba: schoolbook n x n against one Karatsuba level over schoolbook halves
+    best.karatsuba_limbs = SIZE_MAX;
+    for (size_t n : {8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512}) {
+        vector<BASE> a(n), b(n), r(2 * n);
+        thread_engine().Fill(a.data(), n);
+        thread_engine().Fill(b.data(), n);
+
+        double plain = BestTime([&] { MulSchoolbookLimbs(a.data(), n, b.data(), n, r.data()); });
+        double kara = BestTime([&] { MulKaratsubaLimbs(a.data(), n, b.data(), n, n); });
+        log << "karatsuba  " << n << " limbs: schoolbook " << plain * 1e6 << " us, karatsuba " << kara * 1e6 << " us" << endl;
+        if (kara < plain) { best.karatsuba_limbs = n; break; }
+    }
+    if (best.karatsuba_limbs == SIZE_MAX) best.karatsuba_limbs = 512;
+    cur.karatsuba_limbs = best.karatsuba_limbs.load();     // later measurements multiply with the tuned value
+
+    // decimal output: two digits per pass against one divide-and-conquer split
+    best.dc_radix_limbs = SIZE_MAX;
+    for (size_t n : {32, 64, 128, 256, 512, 1024, 2048, 4096}) {
+        BigNumber x = random_bits(n * BASE_SIZE);
+        cur.dc_radix_limbs = n;
+
+        double plain = BestTime([&] { x.DecimalNaive(); });
+        double dc = BestTime([&] { x.ToDecimal(); });
+        log << "dc_radix   " << n << " limbs: naive " << plain * 1e6 << " us, divide and conquer " << dc * 1e6 << " us" << endl;
+        if (dc < plain) { best.dc_radix_limbs = n; break; }
+    }
+    if (best.dc_radix_limbs == SIZE_MAX) best.dc_radix_limbs = 4096;
+    cur.dc_radix_limbs = best.dc_radix_limbs.load();
+
+    // product tree: eight factors of n/8 limbs, sequential against the halves on two threads
+    best.parallel_limbs = SIZE_MAX;
+    if (thread::hardware_concurrency() > 1) {
+        for (size_t n : {2048, 4096, 8192, 16384, 32768, 65536}) {
+            vector<BigNumber> f;
+            for (int i = 0; i < 8; i++) f.push_back(random_bits(n / 8 * BASE_SIZE));
+
+            cur.parallel_limbs = SIZE_MAX;
+            double seq = BestTime([&] { ProductTree(f, 0, f.size()); });
+            cur.parallel_limbs = n;
+            double par = BestTime([&] { ProductTree(f, 0, f.size()); });
+            log << "parallel   " << n << " limbs: one thread " << seq * 1e6 << " us, two threads " << par * 1e6 << " us" << endl;
+            if (par < seq) { best.parallel_limbs = n; break; }
+        }
+    }
+    else log << "parallel   single hardware thread: off" << endl;
+
+    cur = saved;
+    return best;
+}
 
 // ----------  inout  ------------
 
@@ -654,20 +2376,73 @@ void BigNumber::PrintBase256()
     }
 
 
-// print
-ostream& operator<< (ostream& out, const BigNumber& other){
+// two decimal digits per pass: number /= 100 and the remainder come from the same pass
+string BigNumber::DecimalNaive() const
+{
     string output;
-    BASE base_10 = 10;
-    BigNumber number(other);
-    BigNumber zeroNum;
+    BigNumber number(*this);
+    while (number.coefs.size() > 1 && number.coefs.back() == 0) number.coefs.pop_back();
+
+    while (!number.coefs.empty() && !(number.coefs.size() == 1 && number.coefs[0] == 0)) {
+        cancel_point();
+        DBASE r = 0;
+        for (int i = number.coefs.size() - 1; i >= 0; i--) {
+            DBASE cur = (r << BASE_SIZE) + number.coefs[i];
+            number.coefs[i] = BASE(cur / 100);
+            r = cur % 100;
+        }
+        while (number.coefs.size() > 1 && number.coefs.back() == 0) number.coefs.pop_back();
 
-    while (number != zeroNum){
-        BASE tmp = (number % (BASE)base_10).coefs[0];
-        output += (tmp + '0'); // ASSCI TRANS
-        number /= (BASE)base_10;
+        output += char('0' + r % 10); // ASSCI TRANS
+        output += char('0' + r / 10);
     }
+    while (output.size() > 1 && output.back() == '0') output.pop_back();
     if (!output.size()) output = "0";
     reverse(output.begin(), output.end());
+    return output;
+}
+
+/*
+    Divide and conquer: with P = 10^d and x < P^2, x = hi * P + lo, and the
+    digits of x are the digits of hi followed by the d digits of lo (zero padded).
+    pow[i] = 10^(16 * 2^i), each level splits with one DivRem.
+*/
+static void DecimalDC(BigNumber x, const vector<BigNumber>& pow, int level, size_t width, string& out)
+{
+    if (level < 0 || x.getLength() < thresholds().dc_radix_limbs) {
+        string s = x.DecimalNaive();
+        if (width > s.size()) out.append(width - s.size(), '0');
+        out += s;
+        return;
+    }
+    if (!width && x.compare(pow[level]) < 0) {         // leading part: no zero padding
+        DecimalDC(x, pow, level - 1, 0, out);
+        return;
+    }
+
+    size_t digits = (size_t)16 << level;
+    BigNumber lo;
+    BigNumber hi = x.DivRem(pow[level], &lo);
+    DecimalDC(hi, pow, level - 1, width ? width - digits : 0, out);
+    DecimalDC(lo, pow, level - 1, digits, out);
+}
+
+string BigNumber::ToDecimal() const
+{
+    if (coefs.size() < thresholds().dc_radix_limbs) return DecimalNaive();
+
+    // powers 10^16, 10^32, 10^64, ... until pow^2 > x
+    vector<BigNumber> pow(1, FromWord(10000000000000000ULL));
+    while (pow.back().getLength() * 2 <= coefs.size() + 1) pow.push_back(pow.back() * pow.back());
+
+    string out;
+    DecimalDC(*this, pow, (int)pow.size() - 1, 0, out);
+    return out;
+}
+
+// print
+ostream& operator<< (ostream& out, const BigNumber& other){
+    string output = other.ToDecimal();
     cout << output << endl;
     return out;
 }
@@ -681,16 +2456,32 @@ istream& operator>> (istream& in, BigNumber& other){
     other = BigNumber(); 
     for (char c : input_str) {
         BASE digit = c - '0';
-        other = other * (BASE)10 + digit;
+        other.muladd(10, digit);
     }
     while (other.coefs.size() > 1 && other.coefs.back() == 0) other.coefs.pop_back();
+    other.invalidateHash();
     return in;
 }
 
 
-int main()
+int main(int argc, char* argv[])
 {
-    srand(time(nullptr));
+    // BigNumber --tune [profile]: measure this machine and write its thresholds
+    if (argc > 1 && string(argv[1]) == "--tune") {
+        const char* env = getenv("BIGNUMBER_PROFILE");
+        string path = argc > 2 ? argv[2] : env ? env : BIGNUMBER_PROFILE_PATH;
+
+        Thresholds t = tune_thresholds(cout);
+        if (!save_thresholds(path, t)) {
+            cerr << "cannot write " << path << endl;
+            return 1;
+        }
+        thresholds() = t;
+        cout << "profile written to " << path << endl;
+        return 0;
+    }
+
+    seed_random(time(nullptr));
 
     BigNumber a(5);
     a.PrintBase256();
@@ -729,7 +2520,7 @@ int main()
     cout << "d == a : " << (d == a ? "true" : "false") << endl;
 
     // Get test number from user
-    BASE testNum = rand();
+    BASE testNum = BASE(thread_engine().Next());
     cout << "Testing with number: " << (unsigned int)testNum << endl;
 
     // ---- Tests for arithmetic operations with BASE ---
@@ -836,6 +2627,129 @@ int main()
     cout << "a * one = "; mul_one.OutputHex();
     cout << "a == (a * one) : " << (a == mul_one ? "true" : "false") << endl;
 
+    // ---- compare / hash ---
+    cout << "\n--- Compare & Hash Tests ---\n";
+    cout << "a.compare(a) == 0 : " << (a.compare(a) == 0 ? "true" : "false") << endl;
+    cout << "a.compare(a + 1) == -1 : " << (a.compare(a + (BASE)1) == -1 ? "true" : "false") << endl;
+    cout << "(a * b).compare(a) == 1 : " << ((a * b).compare(a) == 1 ? "true" : "false") << endl;
+#if __cplusplus >= 202002L
+    cout << "(a <=> a + 1) < 0 : " << ((a <=> a + (BASE)1) < 0 ? "true" : "false") << endl;
+#endif
+    cout << "hash(a) == hash(copy of a) : " << (std::hash<BigNumber>{}(a) == std::hash<BigNumber>{}(BigNumber(a)) ? "true" : "false") << endl;
+    BigNumber h = a;
+    size_t h_before = h.hash();
+    h += (BASE)1;
+    cout << "hash changes after h += 1 : " << (h.hash() != h_before && h.hash() == (a + (BASE)1).hash() ? "true" : "false") << endl;
+    unordered_set<BigNumber> seen = { a, b, BigNumber(a), a * b };
+    cout << "unordered_set {a, b, a, a * b} size == 3 : " << (seen.size() == 3 ? "true" : "false") << endl;
+
+    // ---- fused multiply-accumulate ---
+    cout << "\n--- addmul / submul / muladd Tests ---\n";
+    BigNumber acc = b;
+    acc.addmul(a, testNum);
+    cout << "b.addmul(a, testNum) == b + a * testNum : " << (acc == b + a * testNum ? "true" : "false") << endl;
+    acc.submul(a, testNum);
+    cout << "then submul(a, testNum) == b : " << (acc == b ? "true" : "false") << endl;
+    acc.addmul(a, b);
+    cout << "b.addmul(a, b) == b + a * b : " << (acc == b + a * b ? "true" : "false") << endl;
+    BigNumber x10 = a;
+    x10.muladd(10, 7);
+    cout << "a.muladd(10, 7) == a * 10 + 7 : " << (x10 == a * (BASE)10 + (BASE)7 ? "true" : "false") << endl;
+    try {
+        BigNumber small;
+        small.submul(a, 2);
+        cout << "submul below zero : no exception\n";
+    } catch (underflow_error&) {
+        cout << "submul below zero : underflow_error\n";
+    }
+
+    // ---- lazy expressions ---
+    cout << "\n--- Lazy Expression Tests ---\n";
+    BigNumber lz;
+    lz = lazy(a) + b + a - b;
+    cout << "lazy(a) + b + a - b == a + a : " << (lz == a + a ? "true" : "false") << endl;
+    lz = lazy(b) + lazy(a) * b;
+    cout << "lazy(b) + lazy(a) * b == b + a * b : " << (lz == b + a * b ? "true" : "false") << endl;
+    BigNumber lz_mod = b + (BASE)1;
+    lz = (lazy(a) * a) % lz_mod;
+    cout << "(lazy(a) * a) % (b + 1) == (a * a) % (b + 1) : " << (lz == (a * a) % lz_mod ? "true" : "false") << endl;
+
+    // ---- async ---
+    cout << "\n--- Async Tests ---\n";
+    future<BigNumber> f_mul = async_mul(a, b);
+    future<string> f_str = async_to_string(a);
+    cout << "async_mul(a, b) == a * b : " << (f_mul.get() == a * b ? "true" : "false") << endl;
+    cout << "async_to_string(a) == a.ToDecimal() : " << (f_str.get() == a.ToDecimal() ? "true" : "false") << endl;
+    CancelToken tok;
+    tok.Cancel();
+    try {
+        async_div(a * b, b, tok).get();
+        cout << "cancelled async_div : finished\n";
+    } catch (OperationCancelled&) {
+        cout << "cancelled async_div : OperationCancelled\n";
+    }
+
+    // ---- machine-word operands ---
+    cout << "\n--- uint64_t / int64_t Operand Tests ---\n";
+    uint64_t w64 = 0x123456789abcdefULL;
+    BigNumber wb = BigNumber::FromWord(w64);
+    cout << "FromWord(w).to_uint64() == w : " << (wb.fits_uint64() && wb.to_uint64() == w64 ? "true" : "false") << endl;
+    cout << "(a * w + 12345) / w == a : " << ((a * w64 + 12345) / w64 == a ? "true" : "false") << endl;
+    cout << "(a * w + 12345) % w == 12345 : " << ((a * w64 + 12345) % w64 == 12345 ? "true" : "false") << endl;
+    cout << "a + (-5) == a - 5 : " << (a + (int64_t)-5 == a - 5 ? "true" : "false") << endl;
+    BigNumber w_max = BigNumber::FromWord(UINT64_MAX);
+    cout << "UINT64_MAX + 1 does not fit : " << (!(w_max + 1).fits_uint64() ? "true" : "false") << endl;
+
+    // ---- Product trees ---
+    cout << "\n--- Product Tree Tests ---\n";
+    cout << "20! = "; factorial(20).OutputHex();                 // 21c3677c82b40000
+    cout << "C(100, 50) = "; binomial(100, 50).OutputHex();      // 145ff5d3b1070380dc8085568
+    cout << "primorial(100) = "; primorial(100).OutputHex();     // 1bc0946e5bb173bc25c4b8131ab1026
+    cout << "C(100, 50) == 100! / (50! * 50!) : "
+         << (binomial(100, 50) == factorial(100) / (factorial(50) * factorial(50)) ? "true" : "false") << endl;
+
+    vector<BigNumber> moduli = { BigNumber(3), BigNumber(2), BigNumber(1), BigNumber(5) };
+    vector<BigNumber> rems = remainder_tree(a, moduli);
+    bool rems_ok = true;
+    for (size_t i = 0; i < moduli.size(); i++)
+        if (rems[i] != a % moduli[i]) rems_ok = false;
+    cout << "remainder_tree(a, m) == a % m_i : " << (rems_ok ? "true" : "false") << endl;
+
+    // ---- Random numbers ---
+    cout << "\n--- Random Number Tests ---\n";
+    RandomEngine eng1(42), eng2(42);
+    cout << "same seed -> same number : " << (random_bits(200, eng1) == random_bits(200, eng2) ? "true" : "false") << endl;
+    cout << "random_bits(100) bit length <= 100 : " << (random_bits(100).getBitLength() <= 100 ? "true" : "false") << endl;
+    BigNumber r_below = random_below(a);
+    cout << "random_below(a) < a : " << (r_below < a ? "true" : "false") << endl;
+    BigNumber r_range = random_range(b, a + b);
+    cout << "b <= random_range(b, a + b) < a + b : " << (b <= r_range && r_range < a + b ? "true" : "false") << endl;
+
+    // ---- Primality ---
+    cout << "\n--- Primality Tests ---\n";
+    string m61Hex = "1FFFFFFFFFFFFFFF";                 // 2^61 - 1, Mersenne prime
+    BigNumber m61(m61Hex);
+    cout << "2^61 - 1 is prime : " << (is_probable_prime(m61) ? "true" : "false") << endl;
+    cout << "2^61 - 1 + 2 is prime : " << (is_probable_prime(m61 + (BASE)2) ? "true" : "false") << endl;
+    cout << "20! + 1 is prime : " << (is_probable_prime(factorial(20) + (BASE)1) ? "true" : "false") << endl;
+    cout << "next_prime(2^61 - 1) = "; next_prime(m61).OutputHex();    // 200000000000000f
+    BigNumber p1 = next_prime(a * b);
+    cout << "next_prime(a * b) is prime : " << (is_probable_prime(p1) ? "true" : "false") << endl;
+
+    // ---- Algorithm thresholds ---
+    cout << "\n--- Threshold Tests ---\n";
+    cout << "karatsuba_limbs = " << thresholds().karatsuba_limbs
+         << ", dc_radix_limbs = " << thresholds().dc_radix_limbs << endl;
+    BigNumber k1 = random_bits(4000), k2 = random_bits(3000);
+    Thresholds t_saved = thresholds();
+    BigNumber k_fast = k1 * k2;
+    string d_fast = k_fast.ToDecimal();
+    thresholds().karatsuba_limbs = SIZE_MAX;
+    thresholds().dc_radix_limbs = SIZE_MAX;
+    cout << "Karatsuba == schoolbook : " << (k_fast == k1 * k2 ? "true" : "false") << endl;
+    cout << "divide and conquer decimal == two-digit passes : " << (d_fast == k_fast.ToDecimal() ? "true" : "false") << endl;
+    thresholds() = t_saved;
+
     // ---- Simple User Input/Output Tests ---
     cout << "\n--- >> << ---\n";
     